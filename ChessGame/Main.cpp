@@ -5,9 +5,21 @@
 #include <string>
 #include <iostream>
 #include <stack>
+#include <array>
+#include <cstdlib>
+#include <algorithm>
+#include <fstream>
+#include <cstdint>
+#include <cstdio>
+#include <thread>
 
 constexpr int BOARD_SIZE = 8;
 constexpr int TILE_SIZE = 80;
+constexpr int PIECE_SPRITE_WIDTH = 56;
+constexpr int PIECE_SPRITE_HEIGHT = 60;
+
+const Color LIGHT_SQUARE_COLOR = { 240, 217, 181, 255 };
+const Color DARK_SQUARE_COLOR = { 181, 136, 99, 255 };
 
 enum class PieceType {
     None = 0,
@@ -46,6 +58,12 @@ public:
     virtual void Undo() = 0;
 };
 
+class Piece;
+
+// Fixed-size grid so the board dimensions are known to the compiler and every
+// row/column access is a constant-stride lookup rather than a nested vector hop.
+using BoardGrid = std::array<std::array<std::unique_ptr<Piece>, BOARD_SIZE>, BOARD_SIZE>;
+
 class Piece {
 public:
     PieceType type;
@@ -58,13 +76,13 @@ public:
 
     virtual ~Piece() {}
 
-    virtual std::vector<Vector2Int> GetValidMoves(const std::vector<std::vector<std::unique_ptr<Piece>>>& board) = 0;
+    virtual std::vector<Vector2Int> GetValidMoves(const BoardGrid& board) = 0;
 
     static bool InBounds(int x, int y) {
         return x >= 0 && x < BOARD_SIZE && y >= 0 && y < BOARD_SIZE;
     }
 
-    static bool CanMoveTo(const std::vector<std::vector<std::unique_ptr<Piece>>>& board, int x, int y, PieceColor ownColor) {
+    static bool CanMoveTo(const BoardGrid& board, int x, int y, PieceColor ownColor) {
         if (!InBounds(x, y)) return false;
         if (!board[y][x]) return true;
         return board[y][x]->color != ownColor;
@@ -79,7 +97,7 @@ class Rook : public Piece {
 public:
     Rook(PieceColor c, Vector2Int pos) : Piece(PieceType::Rook, c, pos) {}
 
-    std::vector<Vector2Int> GetValidMoves(const std::vector<std::vector<std::unique_ptr<Piece>>>& board) override {
+    std::vector<Vector2Int> GetValidMoves(const BoardGrid& board) override {
         std::vector<Vector2Int> moves;
         int dirs[4][2] = { {1,0}, {-1,0}, {0,1}, {0,-1} };
         for (auto& d : dirs) {
@@ -108,7 +126,7 @@ class Knight : public Piece {
 public:
     Knight(PieceColor c, Vector2Int pos) : Piece(PieceType::Knight, c, pos) {}
 
-    std::vector<Vector2Int> GetValidMoves(const std::vector<std::vector<std::unique_ptr<Piece>>>& board) override {
+    std::vector<Vector2Int> GetValidMoves(const BoardGrid& board) override {
         std::vector<Vector2Int> moves;
         int jumps[8][2] = {
             {1,2}, {2,1}, {-1,2}, {-2,1},
@@ -134,7 +152,7 @@ class Bishop : public Piece {
 public:
     Bishop(PieceColor c, Vector2Int pos) : Piece(PieceType::Bishop, c, pos) {}
 
-    std::vector<Vector2Int> GetValidMoves(const std::vector<std::vector<std::unique_ptr<Piece>>>& board) override {
+    std::vector<Vector2Int> GetValidMoves(const BoardGrid& board) override {
         std::vector<Vector2Int> moves;
         int dirs[4][2] = { {1,1}, {1,-1}, {-1,1}, {-1,-1} };
         for (auto& d : dirs) {
@@ -164,7 +182,7 @@ class Queen : public Piece {
 public:
     Queen(PieceColor c, Vector2Int pos) : Piece(PieceType::Queen, c, pos) {}
 
-    std::vector<Vector2Int> GetValidMoves(const std::vector<std::vector<std::unique_ptr<Piece>>>& board) override {
+    std::vector<Vector2Int> GetValidMoves(const BoardGrid& board) override {
         std::vector<Vector2Int> moves;
         int dirs[8][2] = {
             {1,0}, {-1,0}, {0,1}, {0,-1},
@@ -197,7 +215,7 @@ class King : public Piece {
 public:
     King(PieceColor c, Vector2Int pos) : Piece(PieceType::King, c, pos) {}
 
-    std::vector<Vector2Int> GetValidMoves(const std::vector<std::vector<std::unique_ptr<Piece>>>& board) override {
+    std::vector<Vector2Int> GetValidMoves(const BoardGrid& board) override {
         std::vector<Vector2Int> moves;
         for (int dx = -1; dx <= 1; ++dx) {
             for (int dy = -1; dy <= 1; ++dy) {
@@ -223,10 +241,10 @@ class Pawn : public Piece {
 public:
     Pawn(PieceColor c, Vector2Int pos) : Piece(PieceType::Pawn, c, pos) {}
 
-    std::vector<Vector2Int> GetValidMoves(const std::vector<std::vector<std::unique_ptr<Piece>>>& board) override {
+    std::vector<Vector2Int> GetValidMoves(const BoardGrid& board) override {
         std::vector<Vector2Int> moves;
         int direction = (color == PieceColor::White) ? -1 : 1;
-        int startRow = (color == PieceColor::White) ? 6 : 1;
+        int startRow = (color == PieceColor::White) ? BOARD_SIZE - 2 : 1;
         int x = boardPosition.x;
         int y = boardPosition.y;
 
@@ -253,7 +271,7 @@ public:
 
     bool IsPromotion() const override {
         return (color == PieceColor::White && boardPosition.y == 0) ||
-            (color == PieceColor::Black && boardPosition.y == 7);
+            (color == PieceColor::Black && boardPosition.y == BOARD_SIZE - 1);
     }
 
     std::unique_ptr<Piece> Clone() const override {
@@ -283,6 +301,86 @@ public:
     }
 };
 
+enum class BoardEventType {
+    Reset,
+    Moved,
+    Undone
+};
+
+// from/to are the squares the moving piece left and reached (the king, for
+// castling); lastMoveFrom/lastMoveTo describe the move that is last on the
+// board once this event has happened, or (-1, -1) when there is none.
+struct BoardEvent {
+    BoardEventType type;
+    Vector2Int from;
+    Vector2Int to;
+    Vector2Int lastMoveFrom;
+    Vector2Int lastMoveTo;
+};
+
+class BoardObserver {
+public:
+    virtual ~BoardObserver() = default;
+    virtual void OnBoardEvents(const BoardEvent* events, int count) = 0;
+};
+
+// Observer registry with fixed capacity. Events are queued into a
+// preallocated buffer while moves are made and handed to every observer in
+// one batch per Dispatch, so publishing a move never allocates. Observers
+// only ever run from Dispatch, never from inside a Board update.
+class BoardEventBus {
+public:
+    static constexpr int MAX_OBSERVERS = 8;
+    static constexpr int MAX_PENDING = 64;
+
+private:
+    std::array<BoardObserver*, MAX_OBSERVERS> observers;
+    int observerCount;
+    std::array<BoardEvent, MAX_PENDING> pending;
+    int pendingCount;
+
+public:
+    BoardEventBus() : observers(), observerCount(0), pending(), pendingCount(0) {}
+
+    bool Subscribe(BoardObserver* observer) {
+        if (observerCount == MAX_OBSERVERS) return false;
+        observers[observerCount++] = observer;
+        return true;
+    }
+
+    void Unsubscribe(BoardObserver* observer) {
+        for (int i = 0; i < observerCount; ++i) {
+            if (observers[i] == observer) {
+                observers[i] = observers[--observerCount];
+                return;
+            }
+        }
+    }
+
+    // When more moves happen between dispatches than the buffer holds (e.g.
+    // loading a saved game), the queue collapses into a single Reset that
+    // carries the latest state; observers resynchronise from it.
+    void Publish(const BoardEvent& event) {
+        if (pendingCount == MAX_PENDING) {
+            pending[0] = event;
+            pending[0].type = BoardEventType::Reset;
+            pending[0].from = Vector2Int(-1, -1);
+            pending[0].to = Vector2Int(-1, -1);
+            pendingCount = 1;
+            return;
+        }
+        pending[pendingCount++] = event;
+    }
+
+    void Dispatch() {
+        if (pendingCount == 0) return;
+        for (int i = 0; i < observerCount; ++i) {
+            observers[i]->OnBoardEvents(pending.data(), pendingCount);
+        }
+        pendingCount = 0;
+    }
+};
+
 class Board {
 public:
     enum class MoveResult {
@@ -336,50 +434,183 @@ public:
         }
     };
 
-    std::vector<std::vector<std::unique_ptr<Piece>>> squares;
+    class CastleCommand : public Command {
+    private:
+        Board& board;
+        Vector2Int kingFrom;
+        Vector2Int kingTo;
+        Vector2Int rookFrom;
+        Vector2Int rookTo;
+        PieceColor previousTurn;
+
+    public:
+        CastleCommand(Board& b, Vector2Int kf, Vector2Int kt, Vector2Int rf, Vector2Int rt, PieceColor turn)
+            : board(b), kingFrom(kf), kingTo(kt), rookFrom(rf), rookTo(rt), previousTurn(turn) {}
+
+        void Execute() override {
+            board.RelocatePair(kingFrom, kingTo, rookFrom, rookTo, true);
+        }
+
+        void Undo() override {
+            board.RelocatePair(kingTo, kingFrom, rookTo, rookFrom, false);
+
+            board.currentTurn = previousTurn;
+            board.gameOver = false;
+            board.winner = PieceColor::None;
+        }
+    };
+
+    using AttackMap = std::array<std::array<unsigned char, BOARD_SIZE>, BOARD_SIZE>;
+
+    // Moves as they were entered, in play order. Together with the start
+    // position this is enough to replay the game onto a fresh Board.
+    struct PlayedMove {
+        Vector2Int from;
+        Vector2Int to;
+    };
+
+    // Compact copy of a position: one byte per square holding the piece type
+    // in the low three bits and the colour above them.
+    struct Snapshot {
+        std::array<unsigned char, BOARD_SIZE * BOARD_SIZE> cells;
+        PieceColor turn;
+
+        PieceType TypeAt(int x, int y) const {
+            return (PieceType)(cells[y * BOARD_SIZE + x] & 7);
+        }
+        PieceColor ColorAt(int x, int y) const {
+            return (PieceColor)(cells[y * BOARD_SIZE + x] >> 3);
+        }
+    };
+
+    BoardGrid squares;
     PieceColor currentTurn;
     bool gameOver;
     PieceColor winner;
     std::stack<std::unique_ptr<Command>> history;
 
-    Board() : currentTurn(PieceColor::White), gameOver(false), winner(PieceColor::None) {
-        squares.resize(BOARD_SIZE);
-        for (auto& row : squares) {
-            row.resize(BOARD_SIZE);
-        }
-    }
+    // Attacker counts per square for each side, refreshed only when a move is
+    // committed or undone. Trial moves inside HasLegalMoves do not touch them.
+    AttackMap attackMaps[2];
+    int startPosition;
+    std::vector<PlayedMove> moveList;
+    // Squares each entry of moveList actually moved the piece between; differs
+    // from moveList only for castling, which is entered as king-takes-rook.
+    std::vector<PlayedMove> landedMoves;
+    BoardEventBus events;
+
+    Board() : currentTurn(PieceColor::White), gameOver(false), winner(PieceColor::None), attackMaps(),
+        startPosition(STANDARD_START_POSITION) {}
 
     Board(const Board&) = delete;
     Board& operator=(const Board&) = delete;
 
-    void Initialize() {
-        
+    static constexpr int STANDARD_START_POSITION = 518;
+    static constexpr int CHESS960_POSITION_COUNT = 960;
+
+    static_assert(BOARD_SIZE == 8, "BackRankFor implements the 8-file Chess960 numbering only");
+
+    // Scharnagl numbering: bishops, queen and knights are peeled off the index
+    // in turn and the remaining three files are always R, K, R.
+    static std::array<PieceType, BOARD_SIZE> BackRankFor(int position) {
+        static const int knightFiles[10][2] = {
+            {0,1}, {0,2}, {0,3}, {0,4}, {1,2},
+            {1,3}, {1,4}, {2,3}, {2,4}, {3,4}
+        };
+
+        std::array<PieceType, BOARD_SIZE> rank;
+        rank.fill(PieceType::None);
+
+        int n = position;
+        rank[2 * (n % 4) + 1] = PieceType::Bishop;
+        n /= 4;
+        rank[2 * (n % 4)] = PieceType::Bishop;
+        n /= 4;
+        int queenSlot = n % 6;
+        n /= 6;
+
+        int emptyIndex = 0;
+        for (int x = 0; x < BOARD_SIZE; ++x) {
+            if (rank[x] != PieceType::None) continue;
+            if (emptyIndex == queenSlot) {
+                rank[x] = PieceType::Queen;
+                break;
+            }
+            ++emptyIndex;
+        }
+
+        emptyIndex = 0;
+        for (int x = 0; x < BOARD_SIZE; ++x) {
+            if (rank[x] != PieceType::None) continue;
+            if (emptyIndex == knightFiles[n][0] || emptyIndex == knightFiles[n][1])
+                rank[x] = PieceType::Knight;
+            ++emptyIndex;
+        }
+
+        const PieceType remaining[3] = { PieceType::Rook, PieceType::King, PieceType::Rook };
+        int next = 0;
+        for (int x = 0; x < BOARD_SIZE; ++x) {
+            if (rank[x] == PieceType::None)
+                rank[x] = remaining[next++];
+        }
+        return rank;
+    }
+
+    void Initialize(int position = STANDARD_START_POSITION) {
+        for (auto& row : squares) {
+            for (auto& square : row) {
+                square = nullptr;
+            }
+        }
+        history = std::stack<std::unique_ptr<Command>>();
+        moveList.clear();
+        landedMoves.clear();
+        currentTurn = PieceColor::White;
+        gameOver = false;
+        winner = PieceColor::None;
+
+        if (position < 0 || position >= CHESS960_POSITION_COUNT)
+            position = STANDARD_START_POSITION;
+        startPosition = position;
+        std::array<PieceType, BOARD_SIZE> backRank = BackRankFor(startPosition);
 
-        
         for (int i = 0; i < BOARD_SIZE; ++i) {
+            squares[0][i] = PieceFactory::CreatePiece(backRank[i], PieceColor::Black, Vector2Int(i, 0));
             squares[1][i] = PieceFactory::CreatePiece(PieceType::Pawn, PieceColor::Black, Vector2Int(i, 1));
+            squares[BOARD_SIZE - 2][i] = PieceFactory::CreatePiece(PieceType::Pawn, PieceColor::White, Vector2Int(i, BOARD_SIZE - 2));
+            squares[BOARD_SIZE - 1][i] = PieceFactory::CreatePiece(backRank[i], PieceColor::White, Vector2Int(i, BOARD_SIZE - 1));
         }
-        squares[0][0] = PieceFactory::CreatePiece(PieceType::Rook, PieceColor::Black, Vector2Int(0, 0));
-        squares[0][1] = PieceFactory::CreatePiece(PieceType::Knight, PieceColor::Black, Vector2Int(1, 0));
-        squares[0][2] = PieceFactory::CreatePiece(PieceType::Bishop, PieceColor::Black, Vector2Int(2, 0));
-        squares[0][3] = PieceFactory::CreatePiece(PieceType::Queen, PieceColor::Black, Vector2Int(3, 0));
-        squares[0][4] = PieceFactory::CreatePiece(PieceType::King, PieceColor::Black, Vector2Int(4, 0));
-        squares[0][5] = PieceFactory::CreatePiece(PieceType::Bishop, PieceColor::Black, Vector2Int(5, 0));
-        squares[0][6] = PieceFactory::CreatePiece(PieceType::Knight, PieceColor::Black, Vector2Int(6, 0));
-        squares[0][7] = PieceFactory::CreatePiece(PieceType::Rook, PieceColor::Black, Vector2Int(7, 0));
+        RefreshAttackMaps();
+        PublishEvent(BoardEventType::Reset, Vector2Int(-1, -1), Vector2Int(-1, -1));
+    }
 
-        
-        for (int i = 0; i < BOARD_SIZE; ++i) {
-            squares[6][i] = PieceFactory::CreatePiece(PieceType::Pawn, PieceColor::White, Vector2Int(i, 6));
+    void PublishEvent(BoardEventType type, Vector2Int from, Vector2Int to) {
+        BoardEvent event = { type, from, to, Vector2Int(-1, -1), Vector2Int(-1, -1) };
+        if (!landedMoves.empty()) {
+            event.lastMoveFrom = landedMoves.back().from;
+            event.lastMoveTo = landedMoves.back().to;
         }
-        squares[7][0] = PieceFactory::CreatePiece(PieceType::Rook, PieceColor::White, Vector2Int(0, 7));
-        squares[7][1] = PieceFactory::CreatePiece(PieceType::Knight, PieceColor::White, Vector2Int(1, 7));
-        squares[7][2] = PieceFactory::CreatePiece(PieceType::Bishop, PieceColor::White, Vector2Int(2, 7));
-        squares[7][3] = PieceFactory::CreatePiece(PieceType::Queen, PieceColor::White, Vector2Int(3, 7));
-        squares[7][4] = PieceFactory::CreatePiece(PieceType::King, PieceColor::White, Vector2Int(4, 7));
-        squares[7][5] = PieceFactory::CreatePiece(PieceType::Bishop, PieceColor::White, Vector2Int(5, 7));
-        squares[7][6] = PieceFactory::CreatePiece(PieceType::Knight, PieceColor::White, Vector2Int(6, 7));
-        squares[7][7] = PieceFactory::CreatePiece(PieceType::Rook, PieceColor::White, Vector2Int(7, 7));
+        events.Publish(event);
+    }
+
+    static int ColorIndex(PieceColor color) {
+        return (color == PieceColor::White) ? 0 : 1;
+    }
+
+    const AttackMap& GetAttackMap(PieceColor byColor) const {
+        return attackMaps[ColorIndex(byColor)];
+    }
+
+    void RefreshAttackMaps() {
+        attackMaps[ColorIndex(PieceColor::White)] = ComputeAttackMap(PieceColor::White);
+        attackMaps[ColorIndex(PieceColor::Black)] = ComputeAttackMap(PieceColor::Black);
+    }
+
+    bool IsKingAttacked(PieceColor color) const {
+        Vector2Int kingPos = FindKing(color);
+        if (kingPos.x == -1) return false;
+        PieceColor enemy = (color == PieceColor::White) ? PieceColor::Black : PieceColor::White;
+        return GetAttackMap(enemy)[kingPos.y][kingPos.x] > 0;
     }
 
     Vector2Int FindKing(PieceColor color) const {
@@ -398,20 +629,278 @@ public:
         Vector2Int kingPos = FindKing(color);
         if (kingPos.x == -1) return false;
 
-        
+        PieceColor enemy = (color == PieceColor::White) ? PieceColor::Black : PieceColor::White;
+        return IsSquareAttacked(kingPos, enemy);
+    }
+
+    bool HasPiece(int x, int y, PieceType type, PieceColor color) const {
+        if (!Piece::InBounds(x, y) || !squares[y][x]) return false;
+        return squares[y][x]->type == type && squares[y][x]->color == color;
+    }
+
+    // Looks outward from the target instead of generating every enemy move:
+    // one ray per direction, stopping at the first blocker.
+    bool IsSquareAttacked(Vector2Int target, PieceColor byColor) const {
+        static const int jumps[8][2] = {
+            {1,2}, {2,1}, {-1,2}, {-2,1},
+            {1,-2}, {2,-1}, {-1,-2}, {-2,-1}
+        };
+        for (auto& j : jumps) {
+            if (HasPiece(target.x + j[0], target.y + j[1], PieceType::Knight, byColor))
+                return true;
+        }
+
+        for (int dx = -1; dx <= 1; ++dx) {
+            for (int dy = -1; dy <= 1; ++dy) {
+                if (dx == 0 && dy == 0) continue;
+                if (HasPiece(target.x + dx, target.y + dy, PieceType::King, byColor))
+                    return true;
+            }
+        }
+
+        int pawnRow = target.y - ((byColor == PieceColor::White) ? -1 : 1);
+        if (HasPiece(target.x - 1, pawnRow, PieceType::Pawn, byColor) ||
+            HasPiece(target.x + 1, pawnRow, PieceType::Pawn, byColor))
+            return true;
+
+        static const int dirs[8][2] = {
+            {1,0}, {-1,0}, {0,1}, {0,-1},
+            {1,1}, {1,-1}, {-1,1}, {-1,-1}
+        };
+        for (int d = 0; d < 8; ++d) {
+            PieceType slider = (d < 4) ? PieceType::Rook : PieceType::Bishop;
+            int nx = target.x + dirs[d][0];
+            int ny = target.y + dirs[d][1];
+            while (Piece::InBounds(nx, ny) && !squares[ny][nx]) {
+                nx += dirs[d][0];
+                ny += dirs[d][1];
+            }
+            if (HasPiece(nx, ny, slider, byColor) || HasPiece(nx, ny, PieceType::Queen, byColor))
+                return true;
+        }
+        return false;
+    }
+
+    // Every square attacked by one side, with the number of attackers on each.
+    // Built in a single pass over the side's pieces, so callers that need many
+    // squares at once avoid one IsSquareAttacked scan per square.
+    AttackMap ComputeAttackMap(PieceColor byColor) const {
+        AttackMap attacks = {};
         for (int y = 0; y < BOARD_SIZE; y++) {
             for (int x = 0; x < BOARD_SIZE; x++) {
-                if (squares[y][x] && squares[y][x]->color != color) {
-                    std::vector<Vector2Int> moves = squares[y][x]->GetValidMoves(squares);
-                    for (const auto& move : moves) {
-                        if (move == kingPos) {
-                            return true;
-                        }
+                const auto& attacker = squares[y][x];
+                if (!attacker || attacker->color != byColor) continue;
+
+                if (attacker->type == PieceType::Pawn) {
+                    int ny = y + ((byColor == PieceColor::White) ? -1 : 1);
+                    for (int nx : {x - 1, x + 1}) {
+                        if (Piece::InBounds(nx, ny)) ++attacks[ny][nx];
                     }
+                    continue;
                 }
+
+                // Attacks include defended own pieces, which GetValidMoves
+                // leaves out, so rays and jumps are walked here directly.
+                AddPieceAttacks(*attacker, attacks);
             }
         }
-        return false;
+        return attacks;
+    }
+
+    void AddPieceAttacks(const Piece& attacker, AttackMap& attacks) const {
+        static const int dirs[8][2] = {
+            {1,0}, {-1,0}, {0,1}, {0,-1},
+            {1,1}, {1,-1}, {-1,1}, {-1,-1}
+        };
+        static const int jumps[8][2] = {
+            {1,2}, {2,1}, {-1,2}, {-2,1},
+            {1,-2}, {2,-1}, {-1,-2}, {-2,-1}
+        };
+        int x = attacker.boardPosition.x;
+        int y = attacker.boardPosition.y;
+
+        switch (attacker.type) {
+        case PieceType::Knight:
+            for (auto& j : jumps) {
+                if (Piece::InBounds(x + j[0], y + j[1])) ++attacks[y + j[1]][x + j[0]];
+            }
+            break;
+        case PieceType::King:
+            for (auto& d : dirs) {
+                if (Piece::InBounds(x + d[0], y + d[1])) ++attacks[y + d[1]][x + d[0]];
+            }
+            break;
+        case PieceType::Rook:
+        case PieceType::Bishop:
+        case PieceType::Queen: {
+            int first = (attacker.type == PieceType::Bishop) ? 4 : 0;
+            int last = (attacker.type == PieceType::Rook) ? 4 : 8;
+            for (int d = first; d < last; ++d) {
+                int nx = x + dirs[d][0];
+                int ny = y + dirs[d][1];
+                while (Piece::InBounds(nx, ny)) {
+                    ++attacks[ny][nx];
+                    if (squares[ny][nx]) break;
+                    nx += dirs[d][0];
+                    ny += dirs[d][1];
+                }
+            }
+            break;
+        }
+        default:
+            break;
+        }
+    }
+
+    // Castling is entered either as king-takes-own-rook, which is unambiguous
+    // in Chess960, or as the usual two-file king step onto the c/g file.
+    bool GetCastlingMove(Vector2Int from, Vector2Int to, Vector2Int& rookFrom,
+        Vector2Int& kingTo, Vector2Int& rookTo) const {
+        const Piece* king = GetPieceAt(from);
+        if (!king || king->type != PieceType::King || king->hasMoved) return false;
+        int homeRow = (king->color == PieceColor::White) ? BOARD_SIZE - 1 : 0;
+        if (from.y != homeRow || to.y != homeRow || to == from) return false;
+
+        const Piece* target = GetPieceAt(to);
+        int direction = 0;
+        if (target && target->color == king->color && target->type == PieceType::Rook) {
+            direction = (to.x > from.x) ? 1 : -1;
+            rookFrom = to;
+        }
+        else if (!target && std::abs(to.x - from.x) >= 2 && (to.x == 2 || to.x == BOARD_SIZE - 2)) {
+            direction = (to.x > from.x) ? 1 : -1;
+            rookFrom = Vector2Int(-1, -1);
+            for (int x = from.x + direction; Piece::InBounds(x, homeRow); x += direction) {
+                const Piece* p = GetPieceAt(Vector2Int(x, homeRow));
+                if (p && p->color == king->color && p->type == PieceType::Rook) {
+                    rookFrom = Vector2Int(x, homeRow);
+                    break;
+                }
+            }
+            if (rookFrom.x == -1) return false;
+        }
+        else {
+            return false;
+        }
+
+        const Piece* rook = GetPieceAt(rookFrom);
+        if (rook->hasMoved) return false;
+
+        kingTo = Vector2Int(direction > 0 ? BOARD_SIZE - 2 : 2, homeRow);
+        rookTo = Vector2Int(direction > 0 ? BOARD_SIZE - 3 : 3, homeRow);
+
+        int minX = std::min(std::min(from.x, kingTo.x), std::min(rookFrom.x, rookTo.x));
+        int maxX = std::max(std::max(from.x, kingTo.x), std::max(rookFrom.x, rookTo.x));
+        for (int x = minX; x <= maxX; ++x) {
+            if (x == from.x || x == rookFrom.x) continue;
+            if (squares[homeRow][x]) return false;
+        }
+        return true;
+    }
+
+    void RelocatePair(Vector2Int aFrom, Vector2Int aTo, Vector2Int bFrom, Vector2Int bTo, bool moved) {
+        std::unique_ptr<Piece> a = std::move(squares[aFrom.y][aFrom.x]);
+        std::unique_ptr<Piece> b = std::move(squares[bFrom.y][bFrom.x]);
+        a->boardPosition = aTo;
+        a->hasMoved = moved;
+        b->boardPosition = bTo;
+        b->hasMoved = moved;
+        squares[aTo.y][aTo.x] = std::move(a);
+        squares[bTo.y][bTo.x] = std::move(b);
+    }
+
+    bool CanCastle(Vector2Int kingFrom, Vector2Int kingTo, Vector2Int rookFrom, Vector2Int rookTo) {
+        PieceColor mover = squares[kingFrom.y][kingFrom.x]->color;
+        PieceColor enemy = (mover == PieceColor::White) ? PieceColor::Black : PieceColor::White;
+        // Not IsKingAttacked: boards driven by ApplyReplayMove keep no attack maps.
+        if (IsInCheck(mover)) return false;
+
+        // The king's path is tested with king and rook lifted off the rank so
+        // that neither of them shields a square it is about to vacate.
+        std::unique_ptr<Piece> king = std::move(squares[kingFrom.y][kingFrom.x]);
+        std::unique_ptr<Piece> rook = std::move(squares[rookFrom.y][rookFrom.x]);
+        AttackMap enemyAttacks = ComputeAttackMap(enemy);
+        bool pathAttacked = false;
+        int step = (kingTo.x > kingFrom.x) ? 1 : -1;
+        for (int x = kingFrom.x; ; x += step) {
+            if (enemyAttacks[kingFrom.y][x]) {
+                pathAttacked = true;
+                break;
+            }
+            if (x == kingTo.x) break;
+        }
+        squares[kingFrom.y][kingFrom.x] = std::move(king);
+        squares[rookFrom.y][rookFrom.x] = std::move(rook);
+        if (pathAttacked) return false;
+
+        RelocatePair(kingFrom, kingTo, rookFrom, rookTo, true);
+        bool safe = !IsInCheck(mover);
+        RelocatePair(kingTo, kingFrom, rookTo, rookFrom, false);
+        return safe;
+    }
+
+    MoveResult Castle(Vector2Int kingFrom, Vector2Int kingTo, Vector2Int rookFrom, Vector2Int rookTo) {
+        if (!CanCastle(kingFrom, kingTo, rookFrom, rookTo)) return MoveResult::Invalid;
+
+        PieceColor mover = currentTurn;
+        history.push(std::make_unique<CastleCommand>(*this, kingFrom, kingTo, rookFrom, rookTo, mover));
+        history.top()->Execute();
+        moveList.push_back(PlayedMove{ kingFrom, rookFrom });
+        landedMoves.push_back(PlayedMove{ kingFrom, kingTo });
+        PublishEvent(BoardEventType::Moved, kingFrom, kingTo);
+
+        currentTurn = (mover == PieceColor::White) ? PieceColor::Black : PieceColor::White;
+        RefreshAttackMaps();
+        return EvaluateTurn();
+    }
+
+    MoveResult EvaluateTurn() {
+        bool inCheck = IsKingAttacked(currentTurn);
+        bool hasMoves = HasLegalMoves(currentTurn);
+
+        if (inCheck && !hasMoves) {
+            gameOver = true;
+            winner = (currentTurn == PieceColor::White) ? PieceColor::Black : PieceColor::White;
+            return MoveResult::Checkmate;
+        }
+        else if (!inCheck && !hasMoves) {
+            gameOver = true;
+            winner = PieceColor::None;
+            return MoveResult::Stalemate;
+        }
+        else if (inCheck) {
+            return MoveResult::Check;
+        }
+
+        return MoveResult::Success;
+    }
+
+    bool LeavesKingSafe(Vector2Int from, Vector2Int move) {
+        return LeavesKingSafe(from, move, Vector2Int(-1, -1));
+    }
+
+    // kingAfter is where the mover's king stands once the move is made, when
+    // the caller already knows it; (-1, -1) looks it up after the move.
+    bool LeavesKingSafe(Vector2Int from, Vector2Int move, Vector2Int kingAfter) {
+        PieceColor color = squares[from.y][from.x]->color;
+        PieceColor enemy = (color == PieceColor::White) ? PieceColor::Black : PieceColor::White;
+
+        
+        std::unique_ptr<Piece> originalTarget = std::move(squares[move.y][move.x]);
+        squares[from.y][from.x]->boardPosition = move;
+        squares[move.y][move.x] = std::move(squares[from.y][from.x]);
+
+        
+        bool stillInCheck = (kingAfter.x == -1)
+            ? IsInCheck(color)
+            : IsSquareAttacked(kingAfter, enemy);
+
+        
+        squares[from.y][from.x] = std::move(squares[move.y][move.x]);
+        squares[from.y][from.x]->boardPosition = from;
+        squares[move.y][move.x] = std::move(originalTarget);
+
+        return !stillInCheck;
     }
 
     bool HasLegalMoves(PieceColor color) {
@@ -420,22 +909,7 @@ public:
                 if (squares[y][x] && squares[y][x]->color == color) {
                     std::vector<Vector2Int> moves = squares[y][x]->GetValidMoves(squares);
                     for (const auto& move : moves) {
-                        
-                        std::unique_ptr<Piece> originalTarget = std::move(squares[move.y][move.x]);
-                        Vector2Int originalPos = squares[y][x]->boardPosition;
-                        squares[y][x]->boardPosition = move;
-                        squares[move.y][move.x] = std::move(squares[y][x]);
-                        squares[y][x] = nullptr;
-
-                        
-                        bool stillInCheck = IsInCheck(color);
-
-                        
-                        squares[y][x] = std::move(squares[move.y][move.x]);
-                        squares[y][x]->boardPosition = originalPos;
-                        squares[move.y][move.x] = std::move(originalTarget);
-
-                        if (!stillInCheck) {
+                        if (LeavesKingSafe(Vector2Int(x, y), move)) {
                             return true;
                         }
                     }
@@ -445,6 +919,106 @@ public:
         return false;
     }
 
+    // Own pieces standing alone between the king and an enemy slider that
+    // moves along that line, as a bitmask indexed by y * BOARD_SIZE + x.
+    uint64_t PinnedPieces(Vector2Int kingPos, PieceColor color) const {
+        static const int dirs[8][2] = {
+            {1,0}, {-1,0}, {0,1}, {0,-1},
+            {1,1}, {1,-1}, {-1,1}, {-1,-1}
+        };
+        PieceColor enemy = (color == PieceColor::White) ? PieceColor::Black : PieceColor::White;
+        uint64_t pinned = 0;
+        for (int d = 0; d < 8; ++d) {
+            PieceType slider = (d < 4) ? PieceType::Rook : PieceType::Bishop;
+            int nx = kingPos.x + dirs[d][0];
+            int ny = kingPos.y + dirs[d][1];
+            while (Piece::InBounds(nx, ny) && !squares[ny][nx]) {
+                nx += dirs[d][0];
+                ny += dirs[d][1];
+            }
+            if (!Piece::InBounds(nx, ny) || squares[ny][nx]->color != color) continue;
+
+            int px = nx;
+            int py = ny;
+            do {
+                nx += dirs[d][0];
+                ny += dirs[d][1];
+            } while (Piece::InBounds(nx, ny) && !squares[ny][nx]);
+            if (HasPiece(nx, ny, slider, enemy) || HasPiece(nx, ny, PieceType::Queen, enemy))
+                pinned |= (uint64_t)1 << (py * BOARD_SIZE + px);
+        }
+        return pinned;
+    }
+
+    // Legal moves for the side to move in a fixed order: squares scanned row
+    // by row, each piece's moves in GetValidMoves order, castling last and
+    // written as king-takes-own-rook. Archive encoding depends on this order.
+    std::vector<PlayedMove> GenerateLegalMoves() {
+        std::vector<PlayedMove> legal;
+        if (gameOver) return legal;
+        legal.reserve(64);
+
+        PieceColor enemy = (currentTurn == PieceColor::White) ? PieceColor::Black : PieceColor::White;
+        Vector2Int kingPos = FindKing(currentTurn);
+        bool inCheck = kingPos.x != -1 && IsSquareAttacked(kingPos, enemy);
+        uint64_t pinned = (kingPos.x != -1) ? PinnedPieces(kingPos, currentTurn) : 0;
+
+        for (int y = 0; y < BOARD_SIZE; y++) {
+            for (int x = 0; x < BOARD_SIZE; x++) {
+                if (!squares[y][x] || squares[y][x]->color != currentTurn) continue;
+                Vector2Int from(x, y);
+
+                // Outside check only king moves and pinned pieces can expose
+                // the king; every other move is legal without a trial move.
+                bool needsTrial = inCheck || kingPos.x == -1 || squares[y][x]->type == PieceType::King ||
+                    (pinned >> (y * BOARD_SIZE + x) & 1);
+
+                bool isKing = squares[y][x]->type == PieceType::King;
+                std::vector<Vector2Int> moves = squares[y][x]->GetValidMoves(squares);
+                for (const auto& move : moves) {
+                    if (!needsTrial || LeavesKingSafe(from, move, isKing ? move : kingPos)) {
+                        legal.push_back(PlayedMove{ from, move });
+                    }
+                }
+
+                if (squares[y][x]->type != PieceType::King) continue;
+                for (int rx = 0; rx < BOARD_SIZE; ++rx) {
+                    Vector2Int rookFrom, kingTo, rookTo;
+                    Vector2Int target(rx, y);
+                    const Piece* p = GetPieceAt(target);
+                    if (!p || p->type != PieceType::Rook || p->color != currentTurn) continue;
+                    if (GetCastlingMove(from, target, rookFrom, kingTo, rookTo) &&
+                        CanCastle(from, kingTo, rookFrom, rookTo)) {
+                        legal.push_back(PlayedMove{ from, target });
+                    }
+                }
+            }
+        }
+        return legal;
+    }
+
+    // Replay-only counterpart of MovePiece for moves taken from
+    // GenerateLegalMoves. It skips everything a live game needs but a decoder
+    // does not: no legality re-check, history, moveList, events, attack maps
+    // or game-over evaluation. Callers detect the end of the game from an
+    // empty GenerateLegalMoves result.
+    void ApplyReplayMove(const PlayedMove& move) {
+        Vector2Int rookFrom, kingTo, rookTo;
+        if (GetCastlingMove(move.from, move.to, rookFrom, kingTo, rookTo)) {
+            RelocatePair(move.from, kingTo, rookFrom, rookTo, true);
+        }
+        else {
+            squares[move.to.y][move.to.x] = std::move(squares[move.from.y][move.from.x]);
+            Piece* piece = squares[move.to.y][move.to.x].get();
+            piece->boardPosition = move.to;
+            piece->hasMoved = true;
+            if (piece->IsPromotion()) {
+                HandlePromotion(move.to);
+            }
+        }
+        currentTurn = (currentTurn == PieceColor::White) ? PieceColor::Black : PieceColor::White;
+    }
+
     MoveResult MovePiece(Vector2Int from, Vector2Int to) {
         if (gameOver) return MoveResult::Invalid;
         if (!Piece::InBounds(from.x, from.y) || !Piece::InBounds(to.x, to.y))
@@ -453,6 +1027,11 @@ public:
         auto& piece = squares[from.y][from.x];
         if (piece->color != currentTurn) return MoveResult::Invalid;
 
+        Vector2Int rookFrom, kingTo, rookTo;
+        if (GetCastlingMove(from, to, rookFrom, kingTo, rookTo)) {
+            return Castle(from, kingTo, rookFrom, rookTo);
+        }
+
         
         std::vector<Vector2Int> validMoves = piece->GetValidMoves(squares);
         bool moveLegal = false;
@@ -475,7 +1054,6 @@ public:
 
         
         std::unique_ptr<Piece> originalTarget = std::move(squares[to.y][to.x]);
-        Vector2Int originalPos = piece->boardPosition;
 
         piece->boardPosition = to;
         piece->hasMoved = true;
@@ -492,8 +1070,7 @@ public:
         
         if (IsInCheck(previousTurn)) {
             
-            squares[from.y][from.x] = std::move(squares[to.y][to.x]);
-            squares[from.y][from.x]->boardPosition = originalPos;
+            squares[from.y][from.x] = std::move(movedPieceCopy);
             squares[to.y][to.x] = std::move(originalTarget);
             return MoveResult::Invalid;
         }
@@ -507,26 +1084,12 @@ public:
             std::move(movedPieceCopy),
             std::move(capturedPiece),
             wasMoved, promotionOccurred, previousTurn));
+        moveList.push_back(PlayedMove{ from, to });
+        landedMoves.push_back(PlayedMove{ from, to });
+        PublishEvent(BoardEventType::Moved, from, to);
+        RefreshAttackMaps();
 
-        
-        bool inCheck = IsInCheck(currentTurn);
-        bool hasMoves = HasLegalMoves(currentTurn);
-
-        if (inCheck && !hasMoves) {
-            gameOver = true;
-            winner = (currentTurn == PieceColor::White) ? PieceColor::Black : PieceColor::White;
-            return MoveResult::Checkmate;
-        }
-        else if (!inCheck && !hasMoves) {
-            gameOver = true;
-            winner = PieceColor::None;
-            return MoveResult::Stalemate;
-        }
-        else if (inCheck) {
-            return MoveResult::Check;
-        }
-
-        return MoveResult::Success;
+        return EvaluateTurn();
     }
 
     bool UndoLastMove() {
@@ -537,6 +1100,11 @@ public:
         auto& command = history.top();
         command->Undo();
         history.pop();
+        PlayedMove undone = landedMoves.back();
+        moveList.pop_back();
+        landedMoves.pop_back();
+        PublishEvent(BoardEventType::Undone, undone.from, undone.to);
+        RefreshAttackMaps();
 
         return true;
     }
@@ -545,31 +1113,708 @@ public:
         squares[pos.y][pos.x] = PieceFactory::CreatePiece(PieceType::Queen, squares[pos.y][pos.x]->color, pos);
     }
 
-    Piece* GetPieceAt(const Vector2Int& pos) const {
+    Snapshot TakeSnapshot() const {
+        Snapshot snapshot;
+        for (int y = 0; y < BOARD_SIZE; ++y) {
+            for (int x = 0; x < BOARD_SIZE; ++x) {
+                const auto& p = squares[y][x];
+                snapshot.cells[y * BOARD_SIZE + x] = p
+                    ? (unsigned char)((int)p->type | ((int)p->color << 3))
+                    : 0;
+            }
+        }
+        snapshot.turn = currentTurn;
+        return snapshot;
+    }
+
+    Piece* GetPieceAt(const Vector2Int& pos) const {
         if (!Piece::InBounds(pos.x, pos.y)) return nullptr;
         return squares[pos.y][pos.x].get();
     }
 };
 
-class ChessGame {
+// Adaptive frequency model over byte-sized symbols for the range coder.
+// Counts grow as symbols are seen and are halved before the total would
+// exceed what the coder can resolve.
+class AdaptiveByteModel {
+private:
+    static constexpr int SYMBOLS = 256;
+    static constexpr uint32_t INCREMENT = 24;
+    static constexpr uint32_t MAX_TOTAL = 1 << 16;
+
+    uint32_t freq[SYMBOLS];
+    uint32_t total;
+
+public:
+    AdaptiveByteModel() : total(SYMBOLS) {
+        for (auto& f : freq) f = 1;
+    }
+
+    uint32_t Total() const { return total; }
+    uint32_t Freq(int symbol) const { return freq[symbol]; }
+
+    uint32_t CumFreq(int symbol) const {
+        uint32_t cum = 0;
+        for (int i = 0; i < symbol; ++i) cum += freq[i];
+        return cum;
+    }
+
+    int FindSymbol(uint32_t target, uint32_t& cum) const {
+        cum = 0;
+        int symbol = 0;
+        while (cum + freq[symbol] <= target) {
+            cum += freq[symbol];
+            ++symbol;
+        }
+        return symbol;
+    }
+
+    void Update(int symbol) {
+        freq[symbol] += INCREMENT;
+        total += INCREMENT;
+        if (total > MAX_TOTAL - INCREMENT) {
+            total = 0;
+            for (auto& f : freq) {
+                f = (f + 1) / 2;
+                total += f;
+            }
+        }
+    }
+};
+
+// Carry-less range coder (Subbotin): 32-bit low/range, byte-wise output.
+class RangeEncoder {
+private:
+    static constexpr uint32_t TOP = 1u << 24;
+    static constexpr uint32_t BOTTOM = 1u << 16;
+
+    std::vector<unsigned char>& out;
+    uint32_t low;
+    uint32_t range;
+
+public:
+    explicit RangeEncoder(std::vector<unsigned char>& output) : out(output), low(0), range(0xFFFFFFFFu) {}
+
+    void Encode(AdaptiveByteModel& model, int symbol) {
+        range /= model.Total();
+        low += model.CumFreq(symbol) * range;
+        range *= model.Freq(symbol);
+        model.Update(symbol);
+
+        while ((low ^ (low + range)) < TOP || (range < BOTTOM && ((range = (0u - low) & (BOTTOM - 1)), true))) {
+            out.push_back((unsigned char)(low >> 24));
+            low <<= 8;
+            range <<= 8;
+        }
+    }
+
+    void Finish() {
+        for (int i = 0; i < 4; ++i) {
+            out.push_back((unsigned char)(low >> 24));
+            low <<= 8;
+        }
+    }
+};
+
+class RangeDecoder {
+private:
+    static constexpr uint32_t TOP = 1u << 24;
+    static constexpr uint32_t BOTTOM = 1u << 16;
+
+    const unsigned char* in;
+    const unsigned char* end;
+    uint32_t low;
+    uint32_t range;
+    uint32_t code;
+
+    unsigned char NextByte() {
+        return (in < end) ? *in++ : 0;
+    }
+
+public:
+    RangeDecoder(const unsigned char* data, size_t size)
+        : in(data), end(data + size), low(0), range(0xFFFFFFFFu), code(0) {
+        for (int i = 0; i < 4; ++i) {
+            code = (code << 8) | NextByte();
+        }
+    }
+
+    int Decode(AdaptiveByteModel& model) {
+        range /= model.Total();
+        uint32_t target = std::min((code - low) / range, model.Total() - 1);
+        uint32_t cum;
+        int symbol = model.FindSymbol(target, cum);
+
+        low += cum * range;
+        range *= model.Freq(symbol);
+        model.Update(symbol);
+
+        while ((low ^ (low + range)) < TOP || (range < BOTTOM && ((range = (0u - low) & (BOTTOM - 1)), true))) {
+            code = (code << 8) | NextByte();
+            low <<= 8;
+            range <<= 8;
+        }
+        return symbol;
+    }
+};
+
+// Binary game archive. Each move is stored as its index in
+// Board::GenerateLegalMoves for the position it was played from, range coded
+// with a per-game adaptive model. A table of record offsets follows the
+// header, so any game can be decoded without touching the others.
+//
+// Layout: "CGA1", uint32 game count, uint32 offsets[count + 1] relative to
+// the first record, then records of uint16 start position, uint16 ply count
+// and the coded move indices. All integers are little-endian.
+class GameArchive {
+public:
+    struct Game {
+        int startPosition;
+        std::vector<Board::PlayedMove> moves;
+    };
+
+private:
+    std::vector<unsigned char> records;
+    std::vector<uint32_t> offsets;
+
+    static void PutU16(std::vector<unsigned char>& out, uint32_t value) {
+        out.push_back((unsigned char)(value & 0xFF));
+        out.push_back((unsigned char)((value >> 8) & 0xFF));
+    }
+
+    static void PutU32(std::vector<unsigned char>& out, uint32_t value) {
+        PutU16(out, value & 0xFFFF);
+        PutU16(out, value >> 16);
+    }
+
+    static uint32_t GetU16(const unsigned char* p) {
+        return (uint32_t)p[0] | ((uint32_t)p[1] << 8);
+    }
+
+    static uint32_t GetU32(const unsigned char* p) {
+        return GetU16(p) | (GetU16(p + 2) << 16);
+    }
+
+public:
+    GameArchive() : offsets(1, 0) {}
+
+    int GameCount() const { return (int)offsets.size() - 1; }
+
+    static bool EncodeGame(const Game& game, std::vector<unsigned char>& out) {
+        if (game.moves.size() > 0xFFFF) return false;
+        PutU16(out, (uint32_t)game.startPosition);
+        PutU16(out, (uint32_t)game.moves.size());
+
+        Board replay;
+        replay.Initialize(game.startPosition);
+        AdaptiveByteModel model;
+        RangeEncoder encoder(out);
+
+        for (const auto& move : game.moves) {
+            std::vector<Board::PlayedMove> legal = replay.GenerateLegalMoves();
+            int index = -1;
+            for (size_t i = 0; i < legal.size(); ++i) {
+                if (legal[i].from == move.from && legal[i].to == move.to) {
+                    index = (int)i;
+                    break;
+                }
+            }
+            if (index < 0 || index > 255) return false;
+
+            encoder.Encode(model, index);
+            replay.ApplyReplayMove(move);
+        }
+        encoder.Finish();
+        return true;
+    }
+
+    static bool DecodeGame(const unsigned char* data, size_t size, Game& game) {
+        if (size < 4) return false;
+        game.startPosition = (int)GetU16(data);
+        uint32_t plies = GetU16(data + 2);
+        game.moves.clear();
+        game.moves.reserve(plies);
+
+        Board replay;
+        replay.Initialize(game.startPosition);
+        AdaptiveByteModel model;
+        RangeDecoder decoder(data + 4, size - 4);
+
+        for (uint32_t ply = 0; ply < plies; ++ply) {
+            std::vector<Board::PlayedMove> legal = replay.GenerateLegalMoves();
+            if (legal.empty()) return false;
+            int index = decoder.Decode(model);
+            if (index >= (int)legal.size()) return false;
+
+            game.moves.push_back(legal[index]);
+            replay.ApplyReplayMove(legal[index]);
+        }
+        return true;
+    }
+
+    bool AddGame(const Game& game) {
+        std::vector<unsigned char> record;
+        if (!EncodeGame(game, record)) return false;
+        records.insert(records.end(), record.begin(), record.end());
+        offsets.push_back((uint32_t)records.size());
+        return true;
+    }
+
+    bool ReadGame(int index, Game& game) const {
+        if (index < 0 || index >= GameCount()) return false;
+        return DecodeGame(records.data() + offsets[index], offsets[index + 1] - offsets[index], game);
+    }
+
+    // Games are independent, so they are split into contiguous ranges and
+    // decoded on separate threads. Fails as a whole if any record does not
+    // decode, so a corrupt game never passes for a valid one.
+    bool ReadAll(std::vector<Game>& games, int threadCount) const {
+        games.assign(GameCount(), Game());
+        threadCount = std::max(1, std::min(threadCount, GameCount()));
+
+        std::vector<unsigned char> decoded(GameCount(), 0);
+        std::vector<std::thread> workers;
+        int perThread = (GameCount() + threadCount - 1) / threadCount;
+        for (int t = 0; t < threadCount; ++t) {
+            int first = t * perThread;
+            int last = std::min(GameCount(), first + perThread);
+            workers.emplace_back([this, &games, &decoded, first, last]() {
+                for (int i = first; i < last; ++i) {
+                    decoded[i] = ReadGame(i, games[i]) ? 1 : 0;
+                }
+            });
+        }
+        for (auto& worker : workers) {
+            worker.join();
+        }
+
+        for (unsigned char ok : decoded) {
+            if (!ok) {
+                games.clear();
+                return false;
+            }
+        }
+        return true;
+    }
+
+    bool Save(const char* fileName) const {
+        std::vector<unsigned char> header = { 'C', 'G', 'A', '1' };
+        PutU32(header, (uint32_t)GameCount());
+        for (uint32_t offset : offsets) {
+            PutU32(header, offset);
+        }
+
+        // Written to a side file first so a failed write never truncates the
+        // existing archive.
+        std::string tempName = std::string(fileName) + ".tmp";
+        std::ofstream file(tempName, std::ios::binary);
+        if (!file) return false;
+        file.write((const char*)header.data(), header.size());
+        file.write((const char*)records.data(), records.size());
+        file.close();
+        if (file.fail()) {
+            std::remove(tempName.c_str());
+            return false;
+        }
+
+        if (std::rename(tempName.c_str(), fileName) != 0) {
+            // rename does not replace an existing file on Windows. If the second
+            // attempt fails too, the complete archive is still in the .tmp file.
+            std::remove(fileName);
+            if (std::rename(tempName.c_str(), fileName) != 0) return false;
+        }
+        return true;
+    }
+
+    bool Load(const char* fileName) {
+        std::ifstream file(fileName, std::ios::binary);
+        if (!file) return false;
+        std::vector<unsigned char> bytes((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+        if (bytes.size() < 8 || bytes[0] != 'C' || bytes[1] != 'G' || bytes[2] != 'A' || bytes[3] != '1')
+            return false;
+        uint32_t count = GetU32(&bytes[4]);
+        // Bound count by the bytes present before any arithmetic on it, so a
+        // corrupt header cannot wrap size_t on 32-bit builds.
+        if (count >= (bytes.size() - 8) / 4) return false;
+        size_t recordStart = 8 + 4 * ((size_t)count + 1);
+        if (bytes.size() < recordStart) return false;
+
+        std::vector<uint32_t> loadedOffsets(count + 1);
+        for (uint32_t i = 0; i <= count; ++i) {
+            loadedOffsets[i] = GetU32(&bytes[8 + 4 * i]);
+            if (loadedOffsets[i] > bytes.size() - recordStart) return false;
+            if (i > 0 && loadedOffsets[i] < loadedOffsets[i - 1]) return false;
+        }
+
+        offsets.swap(loadedOffsets);
+        records.assign(bytes.begin() + recordStart, bytes.end());
+        return true;
+    }
+};
+
+Rectangle PieceSpriteRect(PieceType type, PieceColor color) {
+    int pieceIndex = 0;
+    switch (type) {
+    case PieceType::Rook: pieceIndex = 0; break;
+    case PieceType::Knight: pieceIndex = 1; break;
+    case PieceType::Bishop: pieceIndex = 2; break;
+    case PieceType::Queen: pieceIndex = 3; break;
+    case PieceType::King: pieceIndex = 4; break;
+    case PieceType::Pawn: pieceIndex = 5; break;
+    default: pieceIndex = 0; break;
+    }
+
+    int row = (color == PieceColor::Black) ? 0 : 1;
+
+    return Rectangle{
+        pieceIndex * PIECE_SPRITE_WIDTH * 1.0f,
+        row * PIECE_SPRITE_HEIGHT * 1.0f,
+        PIECE_SPRITE_WIDTH * 1.0f,
+        PIECE_SPRITE_HEIGHT * 1.0f
+    };
+}
+
+// Minimal GIF89a encoder for board animations. Every frame shares one fixed
+// palette, and each frame after the first stores only the bounding box of
+// pixels that changed, with unchanged pixels marked transparent so the LZW
+// stream collapses them into long runs.
+class GifWriter {
+private:
+    static constexpr int PALETTE_SIZE = 256;
+    static constexpr unsigned char LIGHT_SQUARE_INDEX = 252;
+    static constexpr unsigned char DARK_SQUARE_INDEX = 253;
+    static constexpr unsigned char TRANSPARENT_INDEX = 255;
+    static constexpr int MIN_CODE_SIZE = 8;
+    static constexpr int MAX_CODES = 4096;
+
+    std::ofstream file;
+    int width;
+    int height;
+    std::vector<unsigned char> previousFrame;
+    std::vector<unsigned short> codeTable;
+
+    unsigned char block[255];
+    int blockSize;
+    uint32_t bitBuffer;
+    int bitCount;
+
+    void WriteShort(int value) {
+        file.put((char)(value & 0xFF));
+        file.put((char)((value >> 8) & 0xFF));
+    }
+
+    static unsigned char PaletteIndex(Color c) {
+        if (c.r == LIGHT_SQUARE_COLOR.r && c.g == LIGHT_SQUARE_COLOR.g && c.b == LIGHT_SQUARE_COLOR.b)
+            return LIGHT_SQUARE_INDEX;
+        if (c.r == DARK_SQUARE_COLOR.r && c.g == DARK_SQUARE_COLOR.g && c.b == DARK_SQUARE_COLOR.b)
+            return DARK_SQUARE_INDEX;
+        int r = (c.r * 5 + 127) / 255;
+        int g = (c.g * 6 + 127) / 255;
+        int b = (c.b * 5 + 127) / 255;
+        return (unsigned char)((r * 7 + g) * 6 + b);
+    }
+
+    void WritePalette() {
+        for (int i = 0; i < PALETTE_SIZE; ++i) {
+            Color c = { 0, 0, 0, 255 };
+            if (i < 6 * 7 * 6) {
+                c.r = (unsigned char)((i / 42) * 255 / 5);
+                c.g = (unsigned char)((i / 6 % 7) * 255 / 6);
+                c.b = (unsigned char)((i % 6) * 255 / 5);
+            }
+            else if (i == LIGHT_SQUARE_INDEX) {
+                c = LIGHT_SQUARE_COLOR;
+            }
+            else if (i == DARK_SQUARE_INDEX) {
+                c = DARK_SQUARE_COLOR;
+            }
+            file.put((char)c.r);
+            file.put((char)c.g);
+            file.put((char)c.b);
+        }
+    }
+
+    void FlushBlock() {
+        if (blockSize == 0) return;
+        file.put((char)blockSize);
+        file.write((const char*)block, blockSize);
+        blockSize = 0;
+    }
+
+    void EmitCode(int code, int codeSize) {
+        bitBuffer |= (uint32_t)code << bitCount;
+        bitCount += codeSize;
+        while (bitCount >= 8) {
+            block[blockSize++] = (unsigned char)(bitBuffer & 0xFF);
+            if (blockSize == 255) FlushBlock();
+            bitBuffer >>= 8;
+            bitCount -= 8;
+        }
+    }
+
+    void WriteLzw(const std::vector<unsigned char>& indices) {
+        const int clearCode = 1 << MIN_CODE_SIZE;
+        const int endCode = clearCode + 1;
+
+        file.put((char)MIN_CODE_SIZE);
+        blockSize = 0;
+        bitBuffer = 0;
+        bitCount = 0;
+
+        // codeTable[prefix * 256 + next] holds the code for prefix+next, or 0
+        // when absent; 0 is never a valid multi-symbol code.
+        std::fill(codeTable.begin(), codeTable.end(), (unsigned short)0);
+        int codeSize = MIN_CODE_SIZE + 1;
+        int nextCode = endCode + 1;
+        EmitCode(clearCode, codeSize);
+
+        int prefix = indices[0];
+        for (size_t i = 1; i < indices.size(); ++i) {
+            int symbol = indices[i];
+            unsigned short& entry = codeTable[prefix * PALETTE_SIZE + symbol];
+            if (entry != 0) {
+                prefix = entry;
+                continue;
+            }
+
+            EmitCode(prefix, codeSize);
+            if (nextCode < MAX_CODES) {
+                entry = (unsigned short)nextCode++;
+                if (nextCode > (1 << codeSize) && codeSize < 12)
+                    ++codeSize;
+            }
+            else {
+                EmitCode(clearCode, codeSize);
+                std::fill(codeTable.begin(), codeTable.end(), (unsigned short)0);
+                codeSize = MIN_CODE_SIZE + 1;
+                nextCode = endCode + 1;
+            }
+            prefix = symbol;
+        }
+        EmitCode(prefix, codeSize);
+        EmitCode(endCode, codeSize);
+        if (bitCount > 0) EmitCode(0, 8 - bitCount);
+        FlushBlock();
+        file.put(0);
+    }
+
+public:
+    GifWriter() : width(0), height(0), blockSize(0), bitBuffer(0), bitCount(0) {}
+
+    bool Open(const char* fileName, int w, int h) {
+        file.open(fileName, std::ios::binary);
+        if (!file) return false;
+        width = w;
+        height = h;
+        previousFrame.clear();
+        codeTable.assign(MAX_CODES * PALETTE_SIZE, 0);
+
+        file.write("GIF89a", 6);
+        WriteShort(width);
+        WriteShort(height);
+        file.put((char)0xF7);
+        file.put(0);
+        file.put(0);
+        WritePalette();
+
+        file.put((char)0x21);
+        file.put((char)0xFF);
+        file.put((char)11);
+        file.write("NETSCAPE2.0", 11);
+        file.put((char)3);
+        file.put((char)1);
+        WriteShort(0);
+        file.put(0);
+        return true;
+    }
+
+    // pixels is a width * height RGBA buffer; delay is in 1/100 s.
+    void AddFrame(const Color* pixels, int delay) {
+        std::vector<unsigned char> frame(width * height);
+        for (int i = 0; i < width * height; ++i) {
+            frame[i] = PaletteIndex(pixels[i]);
+        }
+
+        int left = 0, top = 0, right = width - 1, bottom = height - 1;
+        bool delta = !previousFrame.empty();
+        if (delta) {
+            left = width;
+            top = height;
+            right = -1;
+            bottom = -1;
+            for (int y = 0; y < height; ++y) {
+                for (int x = 0; x < width; ++x) {
+                    if (frame[y * width + x] == previousFrame[y * width + x]) continue;
+                    left = std::min(left, x);
+                    right = std::max(right, x);
+                    top = std::min(top, y);
+                    bottom = std::max(bottom, y);
+                }
+            }
+            if (right < 0) {
+                left = top = right = bottom = 0;
+            }
+        }
+
+        std::vector<unsigned char> region;
+        region.reserve((right - left + 1) * (bottom - top + 1));
+        for (int y = top; y <= bottom; ++y) {
+            for (int x = left; x <= right; ++x) {
+                unsigned char index = frame[y * width + x];
+                if (delta && index == previousFrame[y * width + x])
+                    index = TRANSPARENT_INDEX;
+                region.push_back(index);
+            }
+        }
+
+        file.put((char)0x21);
+        file.put((char)0xF9);
+        file.put((char)4);
+        file.put((char)(delta ? 0x05 : 0x04));
+        WriteShort(delay);
+        file.put((char)TRANSPARENT_INDEX);
+        file.put(0);
+
+        file.put((char)0x2C);
+        WriteShort(left);
+        WriteShort(top);
+        WriteShort(right - left + 1);
+        WriteShort(bottom - top + 1);
+        file.put(0);
+        WriteLzw(region);
+
+        previousFrame.swap(frame);
+    }
+
+    bool Close() {
+        file.put((char)0x3B);
+        file.close();
+        return !file.fail();
+    }
+};
+
+// Rasterizes a Board into a CPU-side RGBA image using only raylib's Image
+// API, so it needs neither a window nor a GPU context and can run headless.
+class DiagramRenderer {
+private:
+    Image atlas;
+    int tileSize;
+
+public:
+    DiagramRenderer(Image pieceAtlas, int tile = TILE_SIZE) : atlas(pieceAtlas), tileSize(tile) {}
+
+    int Width() const { return BOARD_SIZE * tileSize; }
+    int Height() const { return BOARD_SIZE * tileSize; }
+
+    Image Render(const Board& board) const {
+        Image diagram = GenImageColor(Width(), Height(), LIGHT_SQUARE_COLOR);
+
+        float scale = (float)tileSize / TILE_SIZE;
+        float pieceWidth = PIECE_SPRITE_WIDTH * scale;
+        float pieceHeight = PIECE_SPRITE_HEIGHT * scale;
+
+        for (int y = 0; y < BOARD_SIZE; ++y) {
+            for (int x = 0; x < BOARD_SIZE; ++x) {
+                if ((x + y) % 2 != 0) {
+                    ImageDrawRectangle(&diagram, x * tileSize, y * tileSize, tileSize, tileSize, DARK_SQUARE_COLOR);
+                }
+
+                const Piece* p = board.GetPieceAt(Vector2Int(x, y));
+                if (!p || atlas.data == nullptr) continue;
+
+                Rectangle destRec = {
+                    x * tileSize + (tileSize - pieceWidth) / 2.0f,
+                    y * tileSize + (tileSize - pieceHeight) / 2.0f,
+                    pieceWidth,
+                    pieceHeight
+                };
+                ImageDraw(&diagram, atlas, PieceSpriteRect(p->type, p->color), destRec, WHITE);
+            }
+        }
+        return diagram;
+    }
+
+    bool ExportPng(const Board& board, const char* fileName) const {
+        Image diagram = Render(board);
+        bool exported = ExportImage(diagram, fileName);
+        UnloadImage(diagram);
+        return exported;
+    }
+
+    // One thumbnail of the final position per game, written as
+    // <prefix>NNN.png. Returns how many were written.
+    int ExportThumbnails(const std::vector<GameArchive::Game>& games, const std::string& prefix) const {
+        int written = 0;
+        for (size_t i = 0; i < games.size(); ++i) {
+            Board position;
+            position.Initialize(games[i].startPosition);
+            for (const auto& move : games[i].moves) {
+                position.ApplyReplayMove(move);
+            }
+
+            char fileName[32];
+            snprintf(fileName, sizeof(fileName), "%03d.png", (int)i);
+            if (ExportPng(position, (prefix + fileName).c_str())) ++written;
+        }
+        return written;
+    }
+
+    // Replays the game's move list onto a fresh board, one frame per ply.
+    bool ExportGif(const Board& game, const char* fileName, int delay = 50) const {
+        GifWriter gif;
+        if (!gif.Open(fileName, Width(), Height())) return false;
+
+        Board replay;
+        replay.Initialize(game.startPosition);
+        Image frame = Render(replay);
+        gif.AddFrame((const Color*)frame.data, delay);
+        UnloadImage(frame);
+
+        for (const auto& move : game.moveList) {
+            replay.MovePiece(move.from, move.to);
+            frame = Render(replay);
+            gif.AddFrame((const Color*)frame.data, delay);
+            UnloadImage(frame);
+        }
+        return gif.Close();
+    }
+};
+
+class ChessGame : public BoardObserver {
 private:
     Board board;
     Texture2D spriteSheet;
+    Image spriteImage;
     Vector2Int selectedSquare;
     bool pieceSelected;
+    bool showThreats;
     std::string statusMessage;
+    Vector2Int lastMoveFrom;
+    Vector2Int lastMoveTo;
+
+    bool replaying;
+    bool replayPlaying;
+    std::vector<Board::Snapshot> replayPlies;
+    int replayPly;
+    int replaySpeedIndex;
+    float replayClock;
+
+    static constexpr int REPLAY_SPEED_COUNT = 10;
+    const int replaySpeeds[REPLAY_SPEED_COUNT] = { 1, 2, 5, 10, 25, 50, 100, 250, 500, 1000 };
 
 public:
-    ChessGame() : selectedSquare(-1, -1), pieceSelected(false), statusMessage("") {}
+    ChessGame() : spriteImage(), selectedSquare(-1, -1), pieceSelected(false), showThreats(false), statusMessage(""),
+        lastMoveFrom(-1, -1), lastMoveTo(-1, -1), replaying(false), replayPlaying(false), replayPly(0), replaySpeedIndex(3), replayClock(0.0f) {}
 
     void Init() {
+        board.events.Subscribe(this);
         board.Initialize();
 
         
-        Image spriteImage = LoadImage("chess_pieces.png");
+        spriteImage = LoadImage("chess_pieces.png");
         if (spriteImage.data != nullptr) {
             spriteSheet = LoadTextureFromImage(spriteImage);
-            UnloadImage(spriteImage);
         }
         else {
             
@@ -577,9 +1822,167 @@ public:
         }
     }
 
+    void OnBoardEvents(const BoardEvent* events, int count) override {
+        lastMoveFrom = events[count - 1].lastMoveFrom;
+        lastMoveTo = events[count - 1].lastMoveTo;
+    }
+
+    void NewGame(int startPosition) {
+        board.Initialize(startPosition);
+        pieceSelected = false;
+        selectedSquare = Vector2Int(-1, -1);
+    }
+
+    bool SaveGame(const char* fileName) {
+        GameArchive archive;
+        bool archiveExists = std::ifstream(fileName, std::ios::binary).good();
+        if (archiveExists && !archive.Load(fileName)) return false;
+
+        GameArchive::Game game;
+        game.startPosition = board.startPosition;
+        game.moves = board.moveList;
+        return archive.AddGame(game) && archive.Save(fileName);
+    }
+
+    std::string ExportArchiveThumbnails(const char* fileName) {
+        GameArchive archive;
+        std::vector<GameArchive::Game> games;
+        int threads = std::max(1, (int)std::thread::hardware_concurrency());
+        if (!archive.Load(fileName) || !archive.ReadAll(games, threads))
+            return "Could not read games.cga";
+
+        DiagramRenderer renderer(spriteImage, TILE_SIZE / 4);
+        int written = renderer.ExportThumbnails(games, "thumb_");
+        return "Wrote " + std::to_string(written) + " thumbnails";
+    }
+
+    bool LoadLastGame(const char* fileName) {
+        GameArchive archive;
+        GameArchive::Game game;
+        if (!archive.Load(fileName) || !archive.ReadGame(archive.GameCount() - 1, game))
+            return false;
+
+        NewGame(game.startPosition);
+        for (const auto& move : game.moves) {
+            board.MovePiece(move.from, move.to);
+        }
+        return true;
+    }
+
+    Rectangle ReplayScrubBar() const {
+        return Rectangle{ 10.0f, (float)(BOARD_SIZE * TILE_SIZE + 45), (float)(BOARD_SIZE * TILE_SIZE - 20), 16.0f };
+    }
+
+    // Every ply is replayed once up front, so seeking is just an index change.
+    void StartReplay() {
+        replayPlies.clear();
+        replayPlies.reserve(board.moveList.size() + 1);
+
+        Board replay;
+        replay.Initialize(board.startPosition);
+        replayPlies.push_back(replay.TakeSnapshot());
+        for (const auto& move : board.moveList) {
+            replay.MovePiece(move.from, move.to);
+            replayPlies.push_back(replay.TakeSnapshot());
+        }
+
+        replaying = true;
+        replayPlaying = false;
+        replayPly = (int)replayPlies.size() - 1;
+        replayClock = 0.0f;
+    }
+
+    void UpdateReplay() {
+        int lastPly = (int)replayPlies.size() - 1;
+
+        if (IsKeyPressed(KEY_R)) {
+            replaying = false;
+            replayPlies.clear();
+            return;
+        }
+        if (IsKeyPressed(KEY_SPACE)) {
+            if (replayPly == lastPly) replayPly = 0;
+            replayPlaying = !replayPlaying;
+            replayClock = 0.0f;
+        }
+        if (IsKeyPressed(KEY_UP) && replaySpeedIndex < REPLAY_SPEED_COUNT - 1) ++replaySpeedIndex;
+        if (IsKeyPressed(KEY_DOWN) && replaySpeedIndex > 0) --replaySpeedIndex;
+        if (IsKeyPressed(KEY_RIGHT) && replayPly < lastPly) ++replayPly;
+        if (IsKeyPressed(KEY_LEFT) && replayPly > 0) --replayPly;
+        if (IsKeyPressed(KEY_HOME)) replayPly = 0;
+        if (IsKeyPressed(KEY_END)) replayPly = lastPly;
+
+        Rectangle bar = ReplayScrubBar();
+        if (IsMouseButtonDown(MOUSE_LEFT_BUTTON)) {
+            int mx = GetMouseX();
+            int my = GetMouseY();
+            if (my >= bar.y - 6 && my <= bar.y + bar.height + 6 && lastPly > 0) {
+                float t = (mx - bar.x) / bar.width;
+                t = std::max(0.0f, std::min(1.0f, t));
+                replayPly = (int)(t * lastPly + 0.5f);
+                replayPlaying = false;
+            }
+        }
+
+        if (replayPlaying) {
+            replayClock += GetFrameTime() * replaySpeeds[replaySpeedIndex];
+            int advance = (int)replayClock;
+            replayClock -= advance;
+            replayPly = std::min(lastPly, replayPly + advance);
+            if (replayPly == lastPly) replayPlaying = false;
+        }
+    }
+
     void Update() {
         statusMessage = "";
 
+        if (replaying) {
+            UpdateReplay();
+            return;
+        }
+        if (IsKeyPressed(KEY_R)) {
+            StartReplay();
+            return;
+        }
+
+        if (IsKeyPressed(KEY_N)) {
+            NewGame(Board::STANDARD_START_POSITION);
+            return;
+        }
+        if (IsKeyPressed(KEY_F)) {
+            NewGame(GetRandomValue(0, Board::CHESS960_POSITION_COUNT - 1));
+            return;
+        }
+        if (IsKeyPressed(KEY_H)) {
+            showThreats = !showThreats;
+        }
+        if (IsKeyPressed(KEY_S)) {
+            statusMessage = SaveGame("games.cga") ? "Saved to games.cga" : "Could not save game";
+            return;
+        }
+        if (IsKeyPressed(KEY_L)) {
+            statusMessage = LoadLastGame("games.cga") ? "Loaded last game" : "No saved game";
+            return;
+        }
+        if (IsKeyPressed(KEY_T)) {
+            statusMessage = ExportArchiveThumbnails("games.cga");
+            return;
+        }
+        if (IsKeyPressed(KEY_G)) {
+            DiagramRenderer renderer(spriteImage);
+            statusMessage = renderer.ExportGif(board, "game.gif")
+                ? "Saved game.gif"
+                : "Could not save game.gif";
+            return;
+        }
+        if (IsKeyPressed(KEY_P)) {
+            DiagramRenderer renderer(spriteImage);
+            statusMessage = renderer.ExportPng(board, "position.png")
+                ? "Saved position.png"
+                : "Could not save position.png";
+            return;
+        }
+
         
         if (board.gameOver) {
             if (board.winner == PieceColor::None) {
@@ -660,9 +2063,50 @@ public:
         }
     }
 
+    void DrawReplay() {
+        ClearBackground(RAYWHITE);
+        DrawBoard();
+
+        const Board::Snapshot& snapshot = replayPlies[replayPly];
+        for (int y = 0; y < BOARD_SIZE; ++y) {
+            for (int x = 0; x < BOARD_SIZE; ++x) {
+                if (snapshot.TypeAt(x, y) != PieceType::None) {
+                    DrawPiece(snapshot.TypeAt(x, y), snapshot.ColorAt(x, y), x, y);
+                }
+            }
+        }
+
+        int lastPly = (int)replayPlies.size() - 1;
+        std::string plyText = "Replay  ply " + std::to_string(replayPly) + "/" + std::to_string(lastPly) +
+            "  " + std::to_string(replaySpeeds[replaySpeedIndex]) + " plies/s" +
+            (replayPlaying ? "" : "  (paused)");
+        DrawText(plyText.c_str(), 10, BOARD_SIZE * TILE_SIZE + 10, 20, BLACK);
+
+        Rectangle bar = ReplayScrubBar();
+        DrawRectangleRec(bar, LIGHTGRAY);
+        float filled = lastPly > 0 ? bar.width * replayPly / lastPly : bar.width;
+        DrawRectangleRec(Rectangle{ bar.x, bar.y, filled, bar.height }, DARKGRAY);
+
+        std::string replayHint = "Space Play  Left/Right Step  Up/Down Speed  'R' Exit";
+        DrawText(replayHint.c_str(), 10, BOARD_SIZE * TILE_SIZE + 75, 20, DARKGRAY);
+    }
+
     void Draw() {
+        board.events.Dispatch();
+
+        if (replaying) {
+            DrawReplay();
+            return;
+        }
+
         ClearBackground(RAYWHITE);
         DrawBoard();
+        if (lastMoveFrom.x != -1) {
+            DrawLastMove();
+        }
+        if (showThreats) {
+            DrawThreats();
+        }
         DrawPieces();
 
         
@@ -691,71 +2135,84 @@ public:
         }
 
         
-        std::string undoHint = "Press 'U' to Undo";
+        std::string undoHint = "'U' Undo  'S' Save  'L' Load  'T' Thumbs";
         int hintWidth = MeasureText(undoHint.c_str(), 20);
         DrawText(undoHint.c_str(),
             BOARD_SIZE * TILE_SIZE - hintWidth - 10,
             BOARD_SIZE * TILE_SIZE + 10, 20, DARKGRAY);
+
+        std::string newGameHint = "'N' New 'F' 960 'H' Threats 'P' PNG 'G' GIF 'R' Replay";
+        DrawText(newGameHint.c_str(), 10, BOARD_SIZE * TILE_SIZE + 75, 20, DARKGRAY);
     }
 
     void DrawBoard() {
-        Color light = { 240, 217, 181, 255 };    
-        Color dark = { 181, 136, 99, 255 };       
-
         for (int y = 0; y < BOARD_SIZE; ++y) {
             for (int x = 0; x < BOARD_SIZE; ++x) {
                 bool isLight = (x + y) % 2 == 0;
                 DrawRectangle(x * TILE_SIZE, y * TILE_SIZE,
                     TILE_SIZE, TILE_SIZE,
-                    isLight ? light : dark);
+                    isLight ? LIGHT_SQUARE_COLOR : DARK_SQUARE_COLOR);
             }
         }
     }
 
-    void DrawPieces() {
-        const int pieceWidth = 56;   
-        const int pieceHeight = 60;  
+    void DrawLastMove() {
+        for (const Vector2Int& square : { lastMoveFrom, lastMoveTo }) {
+            DrawRectangle(square.x * TILE_SIZE, square.y * TILE_SIZE,
+                TILE_SIZE, TILE_SIZE, Fade(YELLOW, 0.35f));
+        }
+    }
 
+    // Reads the attack maps Board keeps up to date on each move, so the
+    // overlay costs nothing beyond the rectangles it draws.
+    void DrawThreats() {
         for (int y = 0; y < BOARD_SIZE; ++y) {
             for (int x = 0; x < BOARD_SIZE; ++x) {
-                const auto& piecePtr = board.squares[y][x];
-                if (piecePtr) {
-                    PieceColor c = piecePtr->color;
-                    PieceType t = piecePtr->type;
-
-                    
-                    int pieceIndex = 0;
-                    switch (t) {
-                    case PieceType::Rook: pieceIndex = 0; break;
-                    case PieceType::Knight: pieceIndex = 1; break;
-                    case PieceType::Bishop: pieceIndex = 2; break;
-                    case PieceType::Queen: pieceIndex = 3; break;
-                    case PieceType::King: pieceIndex = 4; break;
-                    case PieceType::Pawn: pieceIndex = 5; break;
-                    default: pieceIndex = 0; break;
-                    }
+                const Piece* p = board.GetPieceAt(Vector2Int(x, y));
+                if (!p) continue;
+
+                PieceColor enemy = (p->color == PieceColor::White) ? PieceColor::Black : PieceColor::White;
+                int attackers = board.GetAttackMap(enemy)[y][x];
+                if (attackers == 0) continue;
+
+                int defenders = board.GetAttackMap(p->color)[y][x];
+                Rectangle square = {
+                    (float)(x * TILE_SIZE),
+                    (float)(y * TILE_SIZE),
+                    (float)TILE_SIZE,
+                    (float)TILE_SIZE
+                };
+                if (defenders == 0) {
+                    DrawRectangleRec(square, Fade(RED, 0.45f));
+                }
+                else {
+                    DrawRectangleLinesEx(square, 3, ORANGE);
+                }
+            }
+        }
+    }
 
-                    
-                    int row = (c == PieceColor::Black) ? 0 : 1;
+    void DrawPiece(PieceType type, PieceColor color, int x, int y) {
+        Rectangle sourceRec = PieceSpriteRect(type, color);
 
-                    
-                    Rectangle sourceRec = {
-                        pieceIndex * pieceWidth * 1.0f,
-                        row * pieceHeight * 1.0f,
-                        pieceWidth * 1.0f,
-                        pieceHeight * 1.0f
-                    };
+        
+        Rectangle destRec = {
+            x * TILE_SIZE + (TILE_SIZE - PIECE_SPRITE_WIDTH) / 2.0f,
+            y * TILE_SIZE + (TILE_SIZE - PIECE_SPRITE_HEIGHT) / 2.0f,
+            (float)PIECE_SPRITE_WIDTH,
+            (float)PIECE_SPRITE_HEIGHT
+        };
 
-                    
-                    Rectangle destRec = {
-                        x * TILE_SIZE + (TILE_SIZE - pieceWidth) / 2.0f,
-                        y * TILE_SIZE + (TILE_SIZE - pieceHeight) / 2.0f,
-                        (float)pieceWidth,
-                        (float)pieceHeight
-                    };
+        
+        DrawTexturePro(spriteSheet, sourceRec, destRec, { 0,0 }, 0.0f, WHITE);
+    }
 
-                    
-                    DrawTexturePro(spriteSheet, sourceRec, destRec, { 0,0 }, 0.0f, WHITE);
+    void DrawPieces() {
+        for (int y = 0; y < BOARD_SIZE; ++y) {
+            for (int x = 0; x < BOARD_SIZE; ++x) {
+                const auto& piecePtr = board.squares[y][x];
+                if (piecePtr) {
+                    DrawPiece(piecePtr->type, piecePtr->color, x, y);
                 }
             }
         }
@@ -763,6 +2220,7 @@ public:
 
     void Close() {
         UnloadTexture(spriteSheet);
+        UnloadImage(spriteImage);
     }
 };
 